@@ -1,12 +1,18 @@
 // zombies.cpp
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <algorithm>
 #include <cstdlib>
 #include <cctype>
 #include <ctime>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <chrono>
 using namespace std;
 
 ///////////////////////////////////////////////////////////////////////////
@@ -16,6 +22,9 @@ using namespace std;
 const int MAXROWS = 20;              // max number of rows in the arena
 const int MAXCOLS = 20;              // max number of columns in the arena
 const int MAXZOMBIES = 100;          // max number of zombies allowed
+const int EVENTBUFSIZE = 65536;      // bytes an EventLog buffers per write
+const int RECORDWIDTH = 48;          // width of a Recorder's terminal
+const int RECORDLINES = MAXROWS + 6; // lines a Recorder keeps per frame
 
 const int NORTH = 0;
 const int EAST  = 1;
@@ -26,12 +35,29 @@ const int NUMDIRS = 4;
 const int EMPTY      = 0;
 const int HAS_BRAIN  = 1;
 
+  // Turn results reported by the player's actions.  The PLAYER_MOVED_*
+  // codes line up with the direction constants above.
+const int PLAYER_MOVED_NORTH        = 0;
+const int PLAYER_MOVED_EAST         = 1;
+const int PLAYER_MOVED_SOUTH        = 2;
+const int PLAYER_MOVED_WEST         = 3;
+const int PLAYER_STOOD              = 4;
+const int PLAYER_WALKED_INTO_ZOMBIE = 5;
+const int BRAIN_DROPPED             = 6;
+const int BRAIN_ALREADY_THERE       = 7;
+
 ///////////////////////////////////////////////////////////////////////////
 // Type definitions
 ///////////////////////////////////////////////////////////////////////////
 
 class Arena;  // This is needed to let the compiler know that Arena is a
               // type name, since it's mentioned in the Zombie declaration.
+class EventLog;
+class Recorder;
+
+  // A move policy chooses the player's move:  it sets bestDir and returns
+  // true to move that way, or returns false to stand and drop a brain.
+typedef bool (*MovePolicy)(const Arena& a, int r, int c, int& bestDir);
 
 class Zombie
 {
@@ -43,11 +69,14 @@ class Zombie
     int  row() const;
     int  col() const;
     bool isDead() const;
+    int  brainsEaten() const;
 
       // Mutators
     void move();
 
   private:
+    friend class Arena;		//An Arena rebinds the zombies it copies
+
     Arena* m_arena;
     int    m_row;
     int    m_col;
@@ -70,15 +99,17 @@ class Player
       // Mutators
     string dropBrain();
     string move(int dir);
+    int    dropBrainResult();
+    int    moveResult(int dir);
     void   setDead();
 
   private:
+    friend class Arena;		//An Arena rebinds the player it copies
+
     Arena* m_arena;
     int    m_row;
     int    m_col;
     bool   m_dead;
-	Zombie* m_zombies[MAXZOMBIES];
-	int		m_nZombies;
 };
 
 class Arena
@@ -86,7 +117,9 @@ class Arena
   public:
       // Constructor/destructor
     Arena(int nRows, int nCols);
+    Arena(const Arena& other);
     ~Arena();
+    Arena& operator=(const Arena& other);
 
       // Accessors
     int     rows() const;
@@ -95,25 +128,38 @@ class Arena
     int     zombieCount() const;
     int     getCellStatus(int r, int c) const;
     int     numberOfZombiesAt(int r, int c) const;
+    int     turns() const;
+    void    render(char grid[MAXROWS][MAXCOLS]) const;
     void    display(string msg) const;
+    void    display(const char* msg) const;
 
       // Mutators
     void setCellStatus(int r, int c, int status);
     bool addZombie(int r, int c);
     bool addPlayer(int r, int c);
     void moveZombies();
+    void setEventLog(EventLog* log);
 
   private:
-    int     m_grid[MAXROWS][MAXCOLS];
-    int     m_rows;
-    int     m_cols;
-    Player* m_player;
-    Zombie* m_zombies[MAXZOMBIES];
-    int     m_nZombies;
-    int     m_turns;
+    struct Cell		//Everything a zombie's step reads or writes for one position
+    {
+        int status;		//EMPTY or HAS_BRAIN
+        int zombies;	//Number of zombies here
+    };
+
+    Cell      m_grid[MAXROWS][MAXCOLS];
+    int       m_rows;
+    int       m_cols;
+    Player*   m_player;
+    Zombie*   m_zombies[MAXZOMBIES];
+    int       m_nZombies;
+    int       m_turns;
+    EventLog* m_log;
 
       // Helper functions
     void checkPos(int r, int c) const;
+    void copyFrom(const Arena& other);
+    void release();
 };
 
 class Game
@@ -124,13 +170,84 @@ class Game
     ~Game();
 
       // Mutators
+    void setPolicy(MovePolicy policy);
+    void setEventLog(EventLog* log);
+    void setRecorder(Recorder* recorder);
     void play();
+    bool autoPlay(int maxTurns);
 
   private:
-    Arena* m_arena;
+    Arena*    m_arena;
+    Arena*    m_undo;		//Arena as it was before the current turn
+    MovePolicy m_policy;	//Chooses the move when the player just hits Enter
+    EventLog* m_log;		//Not owned; null unless set
+    Recorder* m_recorder;	//Not owned; null unless set
+    chrono::steady_clock::time_point m_start;	//When play() began
+
+      // Helper functions
+    int  takePlayerTurn();
+    void logPlayerTurn(int result);
+    void show(const char* msg);
+};
+
+  // Writes one NDJSON line per turn event.  Lines are collected in a
+  // fixed buffer and written out in EVENTBUFSIZE chunks, so logging a turn
+  // costs a few formatted appends rather than a stream write per event.
+class EventLog
+{
+  public:
+      // Constructor/destructor
+    EventLog(ostream& out, int sampleEvery);
+    ~EventLog();
+
+      // Accessors
+    int droppedEvents() const;
+
+      // Mutators
+    void beginTurn();
+    void playerAction(int result, int r, int c);
+    void zombieMoved(int fromR, int fromC, int toR, int toC);
+    void brainEaten(int r, int c);
+    void zombieDied(int r, int c);
+    void playerDied(int r, int c);
+    void undo(int turn);
+    void gameOver(bool won);
+    void flush();
+
+  private:
+    ostream& m_out;
+    char     m_buffer[EVENTBUFSIZE];
+    int      m_used;
+    int      m_sampleEvery;
+    int      m_turn;
+    bool     m_sampled;
+    int      m_pending;
+    int      m_dropped;
+
+      // Helper functions
+    void append(const char* line, int len);
+};
+
+  // Writes an asciicast v2 recording of the screens a game displays.  Each
+  // frame is compared line by line with the one before it; only the runs
+  // of a line that changed are written, and the cursor is moved over
+  // unchanged runs instead of redrawing them.
+class Recorder
+{
+  public:
+      // Constructor
+    Recorder(ostream& out);
+
+      // Mutators
+    void frame(const Arena& a, const char* msg, double seconds);
+
+  private:
+    ostream& m_out;
+    char     m_lines[RECORDLINES][RECORDWIDTH+1];	//Previous frame
+    int      m_nLines;
 
       // Helper functions
-    string takePlayerTurn();
+    void writeLineDelta(string& data, int line, const char* from, const char* to) const;
 };
 
 ///////////////////////////////////////////////////////////////////////////
@@ -141,6 +258,10 @@ int randInt(int lowest, int highest);
 bool charToDir(char ch, int& dir);
 bool attemptMove(const Arena& a, int dir, int& r, int& c);
 bool recommendMove(const Arena& a, int r, int c, int& bestDir);
+bool alwaysDropBrain(const Arena& a, int r, int c, int& bestDir);
+int runTournament(MovePolicy policy1, MovePolicy policy2, int rows, int cols,
+                  int nZombies, unsigned int seed, int maxGames);
+const char* resultMessage(int result);
 void clearScreen();
 
 ///////////////////////////////////////////////////////////////////////////
@@ -163,6 +284,7 @@ Zombie::Zombie(Arena* ap, int r, int c)
     m_arena = ap;
     m_row = r;
     m_col = c;
+	m_affected = -1;		//Negative until a brain is eaten, so the zombie moves every turn
 	m_brainCounter = 0;		//Brain counter is initially 0
 	m_zDead = false;			//Zombies are initially alive
 }
@@ -182,6 +304,11 @@ bool Zombie::isDead() const
     return m_zDead;		
 }
 
+int Zombie::brainsEaten() const
+{
+    return m_brainCounter;
+}
+
 void Zombie::move()	
 {	
 	//For affected zombies
@@ -253,34 +380,35 @@ int Player::col() const
 }
 
 string Player::dropBrain()
+{
+    return resultMessage(dropBrainResult());
+}
+
+string Player::move(int dir)
+{
+    return resultMessage(moveResult(dir));
+}
+
+int Player::dropBrainResult()
 {
     if (m_arena->getCellStatus(m_row, m_col) == HAS_BRAIN)
-        return "There's already a brain at this spot.";
+        return BRAIN_ALREADY_THERE;
     m_arena->setCellStatus(m_row, m_col, HAS_BRAIN);
-    return "A brain has been dropped.";
+    return BRAIN_DROPPED;
 }
 
-string Player::move(int dir)	
+int Player::moveResult(int dir)	
 {
 	bool callAttemptMove = attemptMove(*m_arena, dir, m_row, m_col);
 	if (m_arena -> numberOfZombiesAt(m_row, m_col) > 0)		//Player will walk into a zombie and die
 			{
 				m_dead = true;
-				return "Player walked into a zombie and died.";
+				return PLAYER_WALKED_INTO_ZOMBIE;
 			}
 	else if (callAttemptMove == false)
-		return "Player couldn't move; player stands.";
-
-	else if (dir == NORTH) 
-		return "Player moved north.";
-	else if (dir == SOUTH) 
-		return "Player moved south."; 
-	else if (dir == WEST) 
-		return "Player moved west."; 
-	else if (dir == EAST) 
-		return "Player moved east.";
+		return PLAYER_STOOD;
 
-	return "Player couldn't move; player stands.";	//So all control paths return a value
+	return dir;		//PLAYER_MOVED_* codes match the direction constants
 }
 
 bool Player::isDead() const
@@ -310,16 +438,34 @@ Arena::Arena(int nRows, int nCols)
     m_player = nullptr;
     m_nZombies = 0;
     m_turns = 0;
+    m_log = nullptr;
     for (int r = 1; r <= m_rows; r++)
         for (int c = 1; c <= m_cols; c++)
+        {
             setCellStatus(r, c, EMPTY);
+            m_grid[r-1][c-1].zombies = 0;
+        }
+}
+
+Arena::Arena(const Arena& other)	//A copy doesn't inherit the event log, so exploring a copy isn't reported
+{
+    m_log = nullptr;
+    copyFrom(other);
 }
 
 Arena::~Arena()		//Destructor releases the player and all remaining dynamically allocated zombies
 {
-    for (int a = 0; a != m_nZombies; a++)
-		delete m_zombies[a];
-		delete m_player;
+    release();
+}
+
+Arena& Arena::operator=(const Arena& other)	//Keeps this arena's own event log
+{
+    if (this != &other)
+    {
+        release();
+        copyFrom(other);
+    }
+    return *this;
 }
 
 int Arena::rows() const
@@ -345,21 +491,23 @@ int Arena::zombieCount() const
 int Arena::getCellStatus(int r, int c) const
 {
     checkPos(r, c);
-    return m_grid[r-1][c-1];
+    return m_grid[r-1][c-1].status;
 }
 
 int Arena::numberOfZombiesAt(int r, int c) const
 {
-	int numOfZombies = 0;	//Counts number of zombies at each coordinate point (row r, column c)
-	for (int k = 0; k != m_nZombies; k++)
-	if (r == (m_zombies[k] -> row()) && c == (m_zombies[k] -> col()) ) //Checks if the r and c correspond to the same coordinate point
-		numOfZombies++;
-	return numOfZombies;	//return number of zombies at each coordinate point (row r, column c)
+	if (r < 1  ||  r > m_rows  ||  c < 1  ||  c > m_cols)	//Positions off the grid (as recommendMove asks about) hold no zombies
+		return 0;
+	return m_grid[r-1][c-1].zombies;	//Kept up to date as zombies are added, move and die
 }
 
-void Arena::display(string msg) const
+int Arena::turns() const
+{
+    return m_turns;
+}
+
+void Arena::render(char displayGrid[MAXROWS][MAXCOLS]) const
 {
-    char displayGrid[MAXROWS][MAXCOLS];
     int r, c;
       // Fill displayGrid with dots (empty) and stars (brains)
     for (r = 1; r <= rows(); r++)
@@ -371,24 +519,13 @@ void Arena::display(string msg) const
 	{
 		for (int c = 1; c <= cols(); c++)	
 		{
-			if (Arena::numberOfZombiesAt(r, c) == 0)		//Display grid is not affected if there are no zombies at that position
+			int n = numberOfZombiesAt(r, c);
+			if (n == 0)		//Display grid is not affected if there are no zombies at that position
 				;
-			else if (Arena::numberOfZombiesAt(r, c) == 1)
+			else if (n == 1)
 				displayGrid[r-1][c-1] = 'Z';
-			else if (Arena::numberOfZombiesAt(r, c) == 2)
-				displayGrid[r-1][c-1] = '2';
-			else if (Arena::numberOfZombiesAt(r, c) == 3)
-				displayGrid[r-1][c-1] = '3';
-			else if (Arena::numberOfZombiesAt(r, c) == 4)
-				displayGrid[r-1][c-1] = '4';
-			else if (Arena::numberOfZombiesAt(r, c) == 5)
-				displayGrid[r-1][c-1] = '5';
-			else if (Arena::numberOfZombiesAt(r, c) == 6)
-				displayGrid[r-1][c-1] = '6';
-			else if (Arena::numberOfZombiesAt(r, c) == 7)
-				displayGrid[r-1][c-1] = '7';
-			else if (Arena::numberOfZombiesAt(r, c) == 8)
-				displayGrid[r-1][c-1] = '8';
+			else if (n < 9)
+				displayGrid[r-1][c-1] = '0' + n;
 			else 
 				displayGrid[r-1][c-1] = '9';
 		}
@@ -397,6 +534,18 @@ void Arena::display(string msg) const
       // Indicate player's position
     if (m_player != nullptr)
         displayGrid[m_player->row()-1][m_player->col()-1] = (m_player->isDead() ? 'X' : '@');
+}
+
+void Arena::display(string msg) const
+{
+    display(msg.c_str());
+}
+
+void Arena::display(const char* msg) const
+{
+    char displayGrid[MAXROWS][MAXCOLS];
+    int r, c;
+    render(displayGrid);
 
       // Draw the grid
     clearScreen();
@@ -409,7 +558,7 @@ void Arena::display(string msg) const
     cout << endl;
 
       // Write message, zombie, and player info
-    if (msg != "")
+    if (msg[0] != '\0')
         cout << msg << endl;
     cout << "There are " << zombieCount() << " zombies remaining." << endl;
     if (m_player == nullptr)
@@ -422,7 +571,7 @@ void Arena::display(string msg) const
 void Arena::setCellStatus(int r, int c, int status)
 {
     checkPos(r, c);
-    m_grid[r-1][c-1] = status;
+    m_grid[r-1][c-1].status = status;
 }
 
 bool Arena::addZombie(int r, int c)
@@ -431,6 +580,7 @@ bool Arena::addZombie(int r, int c)
         return false;
     m_zombies[m_nZombies] = new Zombie(this, r, c);
     m_nZombies++;
+    m_grid[r-1][c-1].zombies++;
     return true;
 }
 
@@ -450,7 +600,24 @@ void Arena::moveZombies()
 	// Move all zombies
 	for (int a = 0; a < m_nZombies ; a++)
 		{
+			int fromR = m_zombies[a] -> row();
+			int fromC = m_zombies[a] -> col();
+			int brains = m_zombies[a] -> brainsEaten();
 			m_zombies[a] -> Zombie::move();		//Move each individual zombie in the game
+			int r = m_zombies[a] -> row();
+			int c = m_zombies[a] -> col();
+			m_grid[fromR-1][fromC-1].zombies--;
+			if (m_zombies[a] -> isDead() == false)
+				m_grid[r-1][c-1].zombies++;
+			if (m_log != nullptr)		//Report what this zombie did
+			{
+				if (r != fromR || c != fromC)
+					m_log -> zombieMoved(fromR, fromC, r, c);
+				if (m_zombies[a] -> brainsEaten() != brains)
+					m_log -> brainEaten(r, c);
+				if (m_zombies[a] -> isDead())
+					m_log -> zombieDied(r, c);
+			}
 			if (m_zombies[a] -> isDead() == true)
 			{
 				delete m_zombies[a];		//Dynamically release the zombie that died
@@ -460,16 +627,20 @@ void Arena::moveZombies()
 			}
 		}
 
-	for (int b = 0; b < m_nZombies; b++)
-		{
-			if (m_player -> row() == m_zombies[b] -> row() && m_player -> col() == m_zombies[b] -> col() )	//If player is in the same position as a zombie, player dies
-			m_player -> setDead();
-		}
+	if (m_player != nullptr && numberOfZombiesAt(m_player -> row(), m_player -> col()) > 0)	//If player is in the same position as a zombie, player dies
+		m_player -> setDead();
+	if (m_log != nullptr && m_player != nullptr && m_player -> isDead())
+		m_log -> playerDied(m_player -> row(), m_player -> col());
 	
       // Another turn has been taken
     m_turns++;
 }
 
+void Arena::setEventLog(EventLog* log)
+{
+    m_log = log;
+}
+
 void Arena::checkPos(int r, int c) const
 {
     if (r < 1  ||  r > m_rows  ||  c < 1  ||  c > m_cols)
@@ -480,6 +651,39 @@ void Arena::checkPos(int r, int c) const
     }
 }
 
+void Arena::copyFrom(const Arena& other)
+{
+    m_rows = other.m_rows;
+    m_cols = other.m_cols;
+    m_turns = other.m_turns;
+    for (int r = 0; r < m_rows; r++)
+        for (int c = 0; c < m_cols; c++)
+            m_grid[r][c] = other.m_grid[r][c];
+
+      // Copy the player and zombies, pointing each copy at this arena
+    m_player = nullptr;
+    if (other.m_player != nullptr)
+    {
+        m_player = new Player(*other.m_player);
+        m_player->m_arena = this;
+    }
+    m_nZombies = other.m_nZombies;
+    for (int k = 0; k < m_nZombies; k++)
+    {
+        m_zombies[k] = new Zombie(*other.m_zombies[k]);
+        m_zombies[k]->m_arena = this;
+    }
+}
+
+void Arena::release()
+{
+    for (int a = 0; a != m_nZombies; a++)
+        delete m_zombies[a];
+    delete m_player;
+    m_nZombies = 0;
+    m_player = nullptr;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 //  Game implementation
 ///////////////////////////////////////////////////////////////////////////
@@ -504,80 +708,420 @@ Game::Game(int rows, int cols, int nZombies)
       // Create arena
     m_arena = new Arena(rows, cols);
 
-      // Add player
-    int rPlayer;
-    int cPlayer;
-    do
-    {
-        rPlayer = randInt(1, rows);
-        cPlayer = randInt(1, cols);
-    } while (m_arena->getCellStatus(rPlayer, cPlayer) != EMPTY);
-    m_arena->addPlayer(rPlayer, cPlayer);
+    m_log = nullptr;
+    m_recorder = nullptr;
 
-      // Populate with zombies
-    while (nZombies > 0)
+      // Add player (the new arena is empty, so any cell will do)
+    int nCells = rows * cols;
+    int playerCell = randInt(0, nCells - 1);
+    m_arena->addPlayer(playerCell / cols + 1, playerCell % cols + 1);
+
+      // Populate with zombies.  Zombies may share a cell but never the
+      // player's, so draw from the other nCells-1 cells and step over the
+      // player's index; every draw places a zombie.
+    for ( ; nZombies > 0; nZombies--)
     {
-        int r = randInt(1, rows);
-        int c = randInt(1, cols);
-        if (r == rPlayer && c == cPlayer)
-            continue;
-        m_arena->addZombie(r, c);
-        nZombies--;
+        int cell = randInt(0, nCells - 2);
+        if (cell >= playerCell)
+            cell++;
+        m_arena->addZombie(cell / cols + 1, cell % cols + 1);
     }
+    m_undo = new Arena(*m_arena);
+    m_policy = recommendMove;
 }
 
 Game::~Game()
 {
     delete m_arena;
+    delete m_undo;
 }
 
-string Game::takePlayerTurn()
+int Game::takePlayerTurn()
 {
     for (;;)
     {
-        cout << "Your move (n/e/s/w/x or nothing): ";
+        cout << "Your move (n/e/s/w/x/u or nothing): ";
         string playerMove;
         getline(cin, playerMove);
 
+        if (playerMove.size() == 1  &&  tolower(playerMove[0]) == 'u')
+        {
+            *m_arena = *m_undo;		//Take back the last turn and ask again
+            if (m_log != nullptr)
+                m_log->undo(m_arena->turns());
+            show("The last turn has been undone.");
+            continue;
+        }
+
         Player* player = m_arena->player();
         int dir;
 
         if (playerMove.size() == 0)
         {
-            if (recommendMove(*m_arena, player->row(), player->col(), dir))
-                return player->move(dir);
+            *m_undo = *m_arena;		//Remember the arena before this turn
+            if (m_policy(*m_arena, player->row(), player->col(), dir))
+                return player->moveResult(dir);
             else
-                return player->dropBrain();
+                return player->dropBrainResult();
         }
         else if (playerMove.size() == 1)
         {
             if (tolower(playerMove[0]) == 'x')
-                return player->dropBrain();
+            {
+                *m_undo = *m_arena;
+                return player->dropBrainResult();
+            }
             else if (charToDir(playerMove[0], dir))
-                return player->move(dir);
+            {
+                *m_undo = *m_arena;
+                return player->moveResult(dir);
+            }
         }
-        cout << "Player move must be nothing, or 1 character n/e/s/w/x." << endl;
+        cout << "Player move must be nothing, or 1 character n/e/s/w/x/u." << endl;
     }
 }
 
+void Game::setPolicy(MovePolicy policy)
+{
+    m_policy = policy;
+}
+
+void Game::setEventLog(EventLog* log)
+{
+    m_log = log;
+    m_arena->setEventLog(log);
+}
+
+void Game::setRecorder(Recorder* recorder)
+{
+    m_recorder = recorder;
+}
+
 void Game::play()
 {
-    m_arena->display("");
+    m_start = chrono::steady_clock::now();
+    show("");
     while ( ! m_arena->player()->isDead()  &&  m_arena->zombieCount() > 0)
     {
-        string msg = takePlayerTurn();
+        int result = takePlayerTurn();
         Player* player = m_arena->player();
+        logPlayerTurn(result);
         if (player->isDead())
             break;
         m_arena->moveZombies();
-        m_arena->display(msg);
+        show(resultMessage(result));
     }
+    if (m_log != nullptr)
+        m_log->gameOver( ! m_arena->player()->isDead());
     if (m_arena->player()->isDead())
         cout << "You lose." << endl;
     else
         cout << "You win." << endl;
 }
 
+  // Play without a display, letting the policy make every move.  Return
+  // true if the player wins within maxTurns turns.
+bool Game::autoPlay(int maxTurns)
+{
+    Player* player = m_arena->player();
+    while ( ! player->isDead()  &&  m_arena->zombieCount() > 0  &&
+            m_arena->turns() < maxTurns)
+    {
+        int dir;
+        int result;
+        if (m_policy(*m_arena, player->row(), player->col(), dir))
+            result = player->moveResult(dir);
+        else
+            result = player->dropBrainResult();
+        logPlayerTurn(result);
+        if (player->isDead())
+            break;
+        m_arena->moveZombies();
+    }
+    bool won = ( ! player->isDead()  &&  m_arena->zombieCount() == 0);
+    if (m_log != nullptr)
+        m_log->gameOver(won);
+    return won;
+}
+
+void Game::logPlayerTurn(int result)
+{
+    if (m_log == nullptr)
+        return;
+    Player* player = m_arena->player();
+    m_log->beginTurn();
+    m_log->playerAction(result, player->row(), player->col());
+    if (result == PLAYER_WALKED_INTO_ZOMBIE)	//The zombies never get to move this turn
+        m_log->playerDied(player->row(), player->col());
+}
+
+void Game::show(const char* msg)
+{
+    m_arena->display(msg);
+    if (m_recorder != nullptr)
+    {
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - m_start;
+        m_recorder->frame(*m_arena, msg, elapsed.count());
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////
+//  EventLog implementation
+///////////////////////////////////////////////////////////////////////////
+
+EventLog::EventLog(ostream& out, int sampleEvery)
+ : m_out(out)
+{
+    if (sampleEvery < 1)
+        sampleEvery = 1;
+    m_used = 0;
+    m_sampleEvery = sampleEvery;
+    m_turn = 0;
+    m_sampled = false;
+    m_pending = 0;
+    m_dropped = 0;
+}
+
+EventLog::~EventLog()
+{
+    flush();
+}
+
+int EventLog::droppedEvents() const
+{
+    return m_dropped;
+}
+
+void EventLog::beginTurn()
+{
+    m_turn++;
+    m_sampled = (m_turn % m_sampleEvery == 0);
+}
+
+void EventLog::playerAction(int result, int r, int c)
+{
+    static const char* const actions[] = {
+        "move_north", "move_east", "move_south", "move_west", "stand",
+        "walk_into_zombie", "drop_brain", "drop_brain_blocked"
+    };
+    if ( ! m_sampled  ||  result < 0  ||  result > BRAIN_ALREADY_THERE)
+        return;
+    char line[128];
+    int len = snprintf(line, sizeof(line),
+        "{\"turn\":%d,\"event\":\"player\",\"action\":\"%s\",\"row\":%d,\"col\":%d}\n",
+        m_turn, actions[result], r, c);
+    append(line, len);
+}
+
+void EventLog::zombieMoved(int fromR, int fromC, int toR, int toC)
+{
+    if ( ! m_sampled)
+        return;
+    char line[128];
+    int len = snprintf(line, sizeof(line),
+        "{\"turn\":%d,\"event\":\"zombie_move\",\"from\":[%d,%d],\"to\":[%d,%d]}\n",
+        m_turn, fromR, fromC, toR, toC);
+    append(line, len);
+}
+
+void EventLog::brainEaten(int r, int c)
+{
+    if ( ! m_sampled)
+        return;
+    char line[128];
+    int len = snprintf(line, sizeof(line),
+        "{\"turn\":%d,\"event\":\"brain_eaten\",\"row\":%d,\"col\":%d}\n",
+        m_turn, r, c);
+    append(line, len);
+}
+
+void EventLog::zombieDied(int r, int c)
+{
+    if ( ! m_sampled)
+        return;
+    char line[128];
+    int len = snprintf(line, sizeof(line),
+        "{\"turn\":%d,\"event\":\"zombie_died\",\"row\":%d,\"col\":%d}\n",
+        m_turn, r, c);
+    append(line, len);
+}
+
+void EventLog::playerDied(int r, int c)
+{
+    if ( ! m_sampled)
+        return;
+    char line[128];
+    int len = snprintf(line, sizeof(line),
+        "{\"turn\":%d,\"event\":\"player_died\",\"row\":%d,\"col\":%d}\n",
+        m_turn, r, c);
+    append(line, len);
+}
+
+  // Mark the turns after the given one as taken back; the next turn logged
+  // is numbered turn+1 again
+void EventLog::undo(int turn)
+{
+    char line[128];		//Always written, whatever the sampling
+    int len = snprintf(line, sizeof(line),
+        "{\"turn\":%d,\"event\":\"undo\",\"back_to\":%d}\n",
+        m_turn, turn);
+    append(line, len);
+    m_turn = turn;
+}
+
+void EventLog::gameOver(bool won)
+{
+    char line[128];		//Always written, whatever the sampling
+    int len = snprintf(line, sizeof(line),
+        "{\"turn\":%d,\"event\":\"game_over\",\"won\":%s}\n",
+        m_turn, (won ? "true" : "false"));
+    append(line, len);
+}
+
+void EventLog::flush()
+{
+    if (m_used == 0)
+        return;
+    m_out.write(m_buffer, m_used);
+    m_out.flush();
+    if ( ! m_out)		//Count events lost to a failed write
+        m_dropped += m_pending;
+    m_used = 0;
+    m_pending = 0;
+}
+
+void EventLog::append(const char* line, int len)
+{
+    if (m_used + len > EVENTBUFSIZE)
+        flush();
+    memcpy(m_buffer + m_used, line, len);
+    m_used += len;
+    m_pending++;
+}
+
+///////////////////////////////////////////////////////////////////////////
+//  Recorder implementation
+///////////////////////////////////////////////////////////////////////////
+
+Recorder::Recorder(ostream& out)
+ : m_out(out)
+{
+    m_nLines = 0;
+}
+
+void Recorder::frame(const Arena& a, const char* msg, double seconds)
+{
+    char lines[RECORDLINES][RECORDWIDTH+1];
+    int n = 0;
+
+      // Lay out the same text Arena::display writes
+    char grid[MAXROWS][MAXCOLS];
+    a.render(grid);
+    for (int r = 0; r < a.rows(); r++, n++)
+    {
+        memcpy(lines[n], grid[r], a.cols());
+        lines[n][a.cols()] = '\0';
+    }
+    lines[n++][0] = '\0';
+    if (msg[0] != '\0')
+        snprintf(lines[n++], RECORDWIDTH+1, "%s", msg);
+    snprintf(lines[n++], RECORDWIDTH+1, "There are %d zombies remaining.", a.zombieCount());
+    if (a.player() == nullptr)
+        snprintf(lines[n++], RECORDWIDTH+1, "There is no player!");
+    else if (a.player()->isDead())
+        snprintf(lines[n++], RECORDWIDTH+1, "The player is dead.");
+    snprintf(lines[n++], RECORDWIDTH+1, "%d turns have been taken.", a.turns());
+
+      // The first frame sizes the recording and starts from a clear screen
+    string data;
+    if (m_nLines == 0)
+    {
+        m_out << "{\"version\": 2, \"width\": " << RECORDWIDTH
+              << ", \"height\": " << a.rows() + 6
+              << ", \"timestamp\": " << time(0) << "}\n";
+        data += "\x1B[2J";
+    }
+
+      // Only write what differs from the previous frame
+    for (int k = 0; k < n  ||  k < m_nLines; k++)
+        writeLineDelta(data, k, (k < m_nLines ? m_lines[k] : ""), (k < n ? lines[k] : ""));
+    memcpy(m_lines, lines, sizeof(lines));
+    m_nLines = n;
+    if (data.empty())
+        return;
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "\x1B[%d;1H", n + 1);		//Park the cursor below the frame
+    data += buf;
+
+      // Write the event as a JSON array, escaping the output text
+    snprintf(buf, sizeof(buf), "[%.6f, \"o\", \"", seconds);
+    m_out << buf;
+    for (size_t k = 0; k != data.size(); k++)
+    {
+        unsigned char ch = data[k];
+        if (ch == '"'  ||  ch == '\\')
+            m_out << '\\' << ch;
+        else if (ch < 0x20)
+        {
+            snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            m_out << buf;
+        }
+        else
+            m_out << ch;
+    }
+    m_out << "\"]\n";
+    m_out.flush();
+}
+
+void Recorder::writeLineDelta(string& data, int line, const char* from, const char* to) const
+{
+    int fromLen = strlen(from);
+    int toLen = strlen(to);
+    char buf[32];
+    int col = -1;		//Column the cursor is at, or -1 if not yet on this line
+    for (int k = 0; k < toLen; )
+    {
+        if (k < fromLen  &&  from[k] == to[k])
+        {
+            k++;
+            continue;
+        }
+
+          // Find the end of this changed run
+        int end = k;
+        while (end < toLen  &&  (end >= fromLen  ||  from[end] != to[end]))
+            end++;
+
+          // Get the cursor to the start of the run
+        if (col == -1)
+            snprintf(buf, sizeof(buf), "\x1B[%d;%dH", line + 1, k + 1);
+        else if (k - col < 4)		//Cheaper to rewrite a short unchanged run
+        {
+            data.append(to + col, k - col);
+            buf[0] = '\0';
+        }
+        else
+            snprintf(buf, sizeof(buf), "\x1B[%dC", k - col);
+        data += buf;
+
+        data.append(to + k, end - k);
+        col = end;
+        k = end;
+    }
+
+      // Erase whatever the previous frame had past the end of this line
+    if (fromLen > toLen)
+    {
+        if (col != toLen)
+        {
+            snprintf(buf, sizeof(buf), "\x1B[%d;%dH", line + 1, toLen + 1);
+            data += buf;
+        }
+        data += "\x1B[K";
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////
 //  Auxiliary function implementation
 ///////////////////////////////////////////////////////////////////////////
@@ -603,6 +1147,79 @@ bool charToDir(char ch, int& dir)
     return true;
 }
 
+  // Never move; just keep dropping brains where the player stands
+bool alwaysDropBrain(const Arena&, int, int, int&)
+{
+    return false;
+}
+
+  // Play pairs of games, one per policy, from the same seeded starting
+  // arena until a sequential probability ratio test on the pairs that the
+  // policies split (one wins, the other doesn't) shows one policy wins
+  // more often, or until maxGames pairs have been played.  Return 1 or 2
+  // for the better policy, or 0 if the test hasn't decided.
+int runTournament(MovePolicy policy1, MovePolicy policy2, int rows, int cols,
+                  int nZombies, unsigned int seed, int maxGames)
+{
+    const int    MAXTURNS = 1000;	//A game still going after this is not a win
+    const double P1 = 0.6;			//Tests P(policy 1 wins a split pair) = P1 against 1-P1
+    const double ERRORRATE = 0.05;	//Chance of picking the wrong policy either way
+    const double bound = log((1 - ERRORRATE) / ERRORRATE);
+    const double step = log(P1 / (1 - P1));
+
+    int wins1 = 0;
+    int wins2 = 0;
+    double llr = 0;		//Log likelihood ratio over the split pairs
+    int winner = 0;
+    int games;
+    for (games = 1; games <= maxGames  &&  winner == 0; games++)
+    {
+        srand(seed + games);
+        Game g1(rows, cols, nZombies);
+        g1.setPolicy(policy1);
+        bool won1 = g1.autoPlay(MAXTURNS);
+
+        srand(seed + games);
+        Game g2(rows, cols, nZombies);
+        g2.setPolicy(policy2);
+        bool won2 = g2.autoPlay(MAXTURNS);
+
+        wins1 += won1;
+        wins2 += won2;
+        if (won1 != won2)
+            llr += (won1 ? step : -step);
+        if (llr >= bound)
+            winner = 1;
+        else if (llr <= -bound)
+            winner = 2;
+    }
+    games--;
+
+    cout << "After " << games << " pairs of games, policy 1 won " << wins1
+         << " and policy 2 won " << wins2 << ": ";
+    if (winner == 0)
+        cout << "no decision." << endl;
+    else
+        cout << "policy " << winner << " is better." << endl;
+    return winner;
+}
+
+  // Return the text for a turn result; only needed when a turn is displayed
+const char* resultMessage(int result)
+{
+    switch (result)
+    {
+      case PLAYER_MOVED_NORTH:        return "Player moved north.";
+      case PLAYER_MOVED_EAST:         return "Player moved east.";
+      case PLAYER_MOVED_SOUTH:        return "Player moved south.";
+      case PLAYER_MOVED_WEST:         return "Player moved west.";
+      case PLAYER_WALKED_INTO_ZOMBIE: return "Player walked into a zombie and died.";
+      case BRAIN_DROPPED:             return "A brain has been dropped.";
+      case BRAIN_ALREADY_THERE:       return "There's already a brain at this spot.";
+      default:                        return "Player couldn't move; player stands.";
+    }
+}
+
 bool attemptMove(const Arena& a, int dir, int& r, int& c)	
 {
 	//Call attemptMove in Player::Move and Zombie::Move
@@ -860,6 +1477,254 @@ void doBasicTests()
     exit(0);
 }
 
+///////////////////////////////////////////////////////////////////////////
+//	Differential Tests
+///////////////////////////////////////////////////////////////////////////
+
+  // A deliberately plain model of the game rules:  zombies live in an
+  // array and are counted by scanning it.  Arena must play every game
+  // exactly the way this model does.
+
+struct RefZombie
+{
+    int r, c;
+    int affected;		//-1 normal, otherwise moves when odd
+    int brains;
+};
+
+struct RefArena
+{
+    int       rows, cols;
+    int       grid[MAXROWS][MAXCOLS];
+    int       pr, pc;
+    bool      dead;
+    RefZombie z[MAXZOMBIES];
+    int       n;
+};
+
+bool refAttemptMove(const RefArena& ra, int dir, int& r, int& c)
+{
+    switch (dir)
+    {
+      case NORTH: if (r == 1)       return false; r--; return true;
+      case EAST:  if (c == ra.cols) return false; c++; return true;
+      case SOUTH: if (r == ra.rows) return false; r++; return true;
+      case WEST:  if (c == 1)       return false; c--; return true;
+    }
+    return false;
+}
+
+int refZombiesAt(const RefArena& ra, int r, int c)
+{
+    int count = 0;
+    for (int k = 0; k < ra.n; k++)
+        if (ra.z[k].r == r  &&  ra.z[k].c == c)
+            count++;
+    return count;
+}
+
+void refPlayerMove(RefArena& ra, int dir)
+{
+    refAttemptMove(ra, dir, ra.pr, ra.pc);
+    if (refZombiesAt(ra, ra.pr, ra.pc) > 0)
+        ra.dead = true;
+}
+
+void refMoveZombies(RefArena& ra)
+{
+    for (int a = 0; a < ra.n; a++)
+    {
+        RefZombie& z = ra.z[a];
+        bool moves = (z.affected < 0  ||  z.affected % 2 == 1);
+        if (z.affected >= 0)
+            z.affected++;
+        if (moves)
+        {
+            refAttemptMove(ra, randInt(0, 3), z.r, z.c);
+            if (ra.grid[z.r-1][z.c-1] == HAS_BRAIN)
+            {
+                ra.grid[z.r-1][z.c-1] = EMPTY;
+                z.affected = 2;
+                z.brains++;
+            }
+        }
+        if (z.brains == 2)
+        {
+              // The zombie shifted into this slot doesn't move this turn
+            ra.n--;
+            for (int x = a; x < ra.n; x++)
+                ra.z[x] = ra.z[x+1];
+        }
+    }
+    if (refZombiesAt(ra, ra.pr, ra.pc) > 0)
+        ra.dead = true;
+}
+
+bool sameState(const Arena& a, const RefArena& ra)
+{
+    if (a.zombieCount() != ra.n  ||  a.player()->isDead() != ra.dead  ||
+        a.player()->row() != ra.pr  ||  a.player()->col() != ra.pc)
+        return false;
+    for (int r = 1; r <= ra.rows; r++)
+        for (int c = 1; c <= ra.cols; c++)
+            if (a.getCellStatus(r, c) != ra.grid[r-1][c-1]  ||
+                a.numberOfZombiesAt(r, c) != refZombiesAt(ra, r, c))
+                return false;
+    return true;
+}
+
+  // Play nScenarios random games through both Arena and the reference
+  // model in lockstep, reseeding rand() identically before each engine's
+  // zombie step.  Halfway through each game a copy of the Arena is forked
+  // off and checked too.  Reports the first scenario and turn at which
+  // the engines disagree.
+void doDifferentialTests(unsigned int seed, int nScenarios)
+{
+    const int MAXTURNS = 60;
+    for (int s = 0; s < nScenarios; s++)
+    {
+        unsigned int scenarioSeed = seed + s;
+        srand(scenarioSeed);
+
+          // Build the same random scenario in both engines
+        int rows = randInt(1, MAXROWS);
+        int cols = randInt(1, MAXCOLS);
+        Arena a(rows, cols);
+        RefArena ra;
+        ra.rows = rows;
+        ra.cols = cols;
+        ra.n = 0;
+        int brainChance = randInt(0, 50);
+        for (int r = 1; r <= rows; r++)
+            for (int c = 1; c <= cols; c++)
+            {
+                int status = (randInt(1, 100) <= brainChance ? HAS_BRAIN : EMPTY);
+                a.setCellStatus(r, c, status);
+                ra.grid[r-1][c-1] = status;
+            }
+        int nZombies = randInt(0, min(MAXZOMBIES, rows * cols));
+        for (int k = 0; k < nZombies; k++)
+        {
+            RefZombie z = { randInt(1, rows), randInt(1, cols), -1, 0 };
+            a.addZombie(z.r, z.c);
+            ra.z[ra.n++] = z;
+        }
+        ra.pr = randInt(1, rows);
+        ra.pc = randInt(1, cols);
+        ra.dead = false;
+        a.addPlayer(ra.pr, ra.pc);
+
+        Arena* fork = nullptr;
+        for (int turn = 1; turn <= MAXTURNS  &&  ! ra.dead  &&  ra.n > 0; turn++)
+        {
+              // Player's turn
+            int action = randInt(0, NUMDIRS);
+            if (action == NUMDIRS)
+            {
+                a.player()->dropBrainResult();
+                if (fork != nullptr)
+                    fork->player()->dropBrainResult();
+                ra.grid[ra.pr-1][ra.pc-1] = HAS_BRAIN;
+            }
+            else
+            {
+                a.player()->moveResult(action);
+                if (fork != nullptr)
+                    fork->player()->moveResult(action);
+                refPlayerMove(ra, action);
+            }
+
+              // Zombies' turn
+            unsigned int turnSeed = rand();
+            if ( ! ra.dead)
+            {
+                srand(turnSeed);
+                a.moveZombies();
+                if (fork != nullptr)
+                {
+                    srand(turnSeed);
+                    fork->moveZombies();
+                }
+                srand(turnSeed);
+                refMoveZombies(ra);
+            }
+            srand(turnSeed);
+
+            if ( ! sameState(a, ra)  ||  (fork != nullptr  &&  ! sameState(*fork, ra)))
+            {
+                cout << "Scenario " << scenarioSeed << " (" << rows << " by "
+                     << cols << ", " << nZombies << " zombies) diverged at turn "
+                     << turn << (sameState(a, ra) ? " in the copied arena" : "")
+                     << endl;
+                delete fork;
+                exit(1);
+            }
+
+            if (turn == MAXTURNS / 2)		//Exercise both ways of copying
+            {
+                if (s % 2 == 0)
+                    fork = new Arena(a);
+                else
+                {
+                    fork = new Arena(1, 1);
+                    *fork = a;
+                }
+            }
+        }
+        delete fork;
+    }
+    cout << "Passed " << nScenarios << " differential scenarios" << endl;
+    exit(0);
+}
+
+///////////////////////////////////////////////////////////////////////////
+//	Event Log Tests
+///////////////////////////////////////////////////////////////////////////
+
+  // Return the turn number on the last "turn" line of an event log
+int lastLoggedTurn(const string& log)
+{
+    size_t pos = log.rfind("{\"turn\":");
+    assert(pos != string::npos);
+    return atoi(log.c_str() + pos + 8);
+}
+
+  // Return N from the last "N turns have been taken." line on a screen
+int lastDisplayedTurn(const string& screen)
+{
+    size_t pos = screen.rfind(" turns have been taken.");
+    assert(pos != string::npos);
+    size_t start = screen.rfind('\n', pos);
+    return atoi(screen.c_str() + (start == string::npos ? 0 : start + 1));
+}
+
+void doEventLogTests()
+{
+      // Play a game that takes a turn back, feeding it input and capturing
+      // its screen, and check the log ends on the turn the screen shows
+    srand(3);
+    Game game(1, 3, 1);
+    game.setPolicy(alwaysDropBrain);		//Once input runs out, stand until eaten
+    ostringstream logText;
+    EventLog* log = new EventLog(logText, 1);
+    game.setEventLog(log);
+
+    istringstream input("x\nx\nu\nx\nu\nu\n");
+    ostringstream screen;
+    streambuf* oldIn = cin.rdbuf(input.rdbuf());
+    streambuf* oldOut = cout.rdbuf(screen.rdbuf());
+    game.play();
+    cin.rdbuf(oldIn);
+    cout.rdbuf(oldOut);
+    delete log;
+
+    string text = logText.str();
+    assert(text.find("\"event\":\"undo\"") != string::npos);
+    assert(lastLoggedTurn(text) == lastDisplayedTurn(screen.str()));
+    cout << "Passed all event log tests" << endl;
+    exit(0);
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // main()
 ///////////////////////////////////////////////////////////////////////////
@@ -874,9 +1739,55 @@ int main()
     Game g(10, 12, 40);
 	//Game g(5, 5, 5);
 
+      // Stream turn events if ZOMBIES_EVENT_LOG names an output file;
+      // ZOMBIES_EVENT_SAMPLE=n keeps only every nth turn
+    ofstream logFile;
+    EventLog* log = nullptr;
+    const char* logPath = getenv("ZOMBIES_EVENT_LOG");
+    if (logPath != nullptr  &&  logPath[0] != '\0')
+    {
+        logFile.open(logPath);
+        if ( ! logFile.is_open())
+        {
+            cout << "***** Cannot open event log " << logPath << "!" << endl;
+            exit(1);
+        }
+        const char* sample = getenv("ZOMBIES_EVENT_SAMPLE");
+        log = new EventLog(logFile, (sample != nullptr ? atoi(sample) : 1));
+        g.setEventLog(log);
+    }
+
+      // Record the screens as an asciicast if ZOMBIES_RECORD names a file
+    ofstream recordFile;
+    Recorder* recorder = nullptr;
+    const char* recordPath = getenv("ZOMBIES_RECORD");
+    if (recordPath != nullptr  &&  recordPath[0] != '\0')
+    {
+        recordFile.open(recordPath);
+        if ( ! recordFile.is_open())
+        {
+            cout << "***** Cannot open recording " << recordPath << "!" << endl;
+            exit(1);
+        }
+        recorder = new Recorder(recordFile);
+        g.setRecorder(recorder);
+    }
+
  //     // Play the game
     g.play();
+    if (log != nullptr)
+    {
+        log->flush();
+        if (log->droppedEvents() > 0)
+            cout << "***** " << log->droppedEvents()
+                 << " events could not be written to " << logPath << endl;
+    }
+    delete log;
+    delete recorder;
 	/*doBasicTests();*/
+	/*doDifferentialTests(1, 1000000);*/
+	/*doEventLogTests();*/
+	/*runTournament(recommendMove, alwaysDropBrain, 5, 5, 5, 1, 100000);*/
 }
 
 